@@ -0,0 +1,448 @@
+// Microbenchmark for the database server internals (database.h).
+//
+// Drives processOperation, the cache lookup, saveDatabaseToFile and
+// loadDatabaseFromFile in-process over a grid of key counts, value sizes
+// and thread counts, writes the results as CSV and optionally compares
+// them against a baseline recorded earlier on the same machine.
+//
+// Build (Linux):  g++ -O2 -std=c++17 -pthread bench.cpp -o bench
+// Run:            ./bench [--quick] [--out FILE] [--threshold PERCENT] [--processes N]
+//                         [--baseline FILE | --write-baseline FILE]
+//
+// Timings are machine-specific, so no baseline is shipped: record one with
+// --write-baseline and compare later runs with --baseline. The benchmark runs
+// in N separate processes (default 3), because a whole process can land on a
+// slower heap layout or CPU and no amount of rounds inside it averages that
+// out. Each case reports the median of the per-process medians and their
+// range. A case is flagged as a regression when even its fastest process is
+// slower than the baseline's slowest by more than the threshold (default
+// 25%), so only slowdowns larger than the threshold plus the baseline's
+// spread are flagged.
+//
+// Exit code is 1 when any case is flagged. Treat it as a coarse hint, not a
+// reliable gate: on a shared or single-CPU host a case can still be flagged
+// with no code change, so rerun a flagged case before acting on it. Samples
+// are interleaved across cases (see runBenchmarks) so that bursts of host
+// noise spread over many cases instead of skewing one.
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "database.h"
+
+const char* BENCH_DATABASE_FILE = "bench_database.txt";
+const int REPETITIONS = 5;   // Rounds (samples per case) in each process
+const int DEFAULT_PROCESSES = 3;  // Separate benchmark processes whose medians are combined
+
+struct BenchResult {
+    std::string stage;
+    size_t keys;
+    size_t valueSize;
+    int threads;
+    size_t ops;
+    double nsPerOp;  // Median (of the per-process medians with --processes > 1)
+    double lowNs;    // Fastest process median, or the lower quartile of a single process
+    double highNs;   // Slowest process median, or the upper quartile of a single process
+
+    // Op count is part of the name so --quick runs never compare against full runs
+    std::string name() const {
+        std::ostringstream oss;
+        oss << stage << "/keys=" << keys << "/value=" << valueSize << "/threads=" << threads
+            << "/ops=" << ops;
+        return oss.str();
+    }
+};
+
+// Median and spread of one case, in ns per operation
+struct Sample {
+    double median;
+    double low;
+    double high;
+};
+
+std::atomic<size_t> sink{0};  // Keeps the compiler from discarding lookups
+
+std::string makeKey(size_t i) {
+    return "key" + std::to_string(i);
+}
+
+// Reset the cache to `keys` entries with values of `valueSize` bytes
+void populateCache(size_t keys, size_t valueSize) {
+    cache.clear();
+    cache.reserve(keys);
+    std::string value(valueSize, 'v');
+    for (size_t i = 0; i < keys; ++i) {
+        cache[makeKey(i)] = value;
+    }
+}
+
+// Run `body(threadIndex, opsPerThread)` on `threads` threads, return elapsed ns
+template <typename Body>
+double timeThreads(int threads, size_t opsPerThread, Body body) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back(body, t, opsPerThread);
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// Summarize the ns-per-operation samples of one case
+Sample summarize(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    return {samples[n / 2], samples[n / 4], samples[(3 * n) / 4]};
+}
+
+// A measurement returns the elapsed ns for the case's `ops` operations
+using Measure = std::function<double()>;
+
+Measure benchRead(size_t keys, int threads, size_t opsPerThread) {
+    std::vector<std::string> operations;
+    for (size_t i = 0; i < keys; ++i) {
+        operations.push_back("READ " + makeKey(i));
+    }
+    return [=] {
+        return timeThreads(threads, opsPerThread, [&](int t, size_t n) {
+            char response[512];
+            for (size_t i = 0; i < n; ++i) {
+                processOperation(operations[(i * threads + t) % keys], response);
+            }
+            sink += (unsigned char)response[0];
+        });
+    };
+}
+
+Measure benchLookup(size_t keys, int threads, size_t opsPerThread) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < keys; ++i) {
+        names.push_back(makeKey(i));
+    }
+    return [=] {
+        return timeThreads(threads, opsPerThread, [&](int t, size_t n) {
+            size_t found = 0;
+            for (size_t i = 0; i < n; ++i) {
+                std::shared_lock<std::shared_mutex> lock(dbMutex);
+                if (const std::string* value = lookupCache(names[(i * threads + t) % keys])) {
+                    found += value->size();
+                }
+            }
+            sink += found;
+        });
+    };
+}
+
+Measure benchUpdate(size_t keys, size_t valueSize, size_t ops) {
+    std::vector<std::string> operations;
+    std::string value(valueSize, 'u');
+    for (size_t i = 0; i < keys; ++i) {
+        operations.push_back("UPDATE " + makeKey(i) + " " + value);
+    }
+    return [=] {
+        return timeThreads(1, ops, [&](int, size_t n) {
+            char response[512];
+            for (size_t i = 0; i < n; ++i) {
+                processOperation(operations[i % keys], response);
+            }
+            sink += (unsigned char)response[0];
+        });
+    };
+}
+
+Measure benchSave(size_t ops) {
+    return [=] {
+        return timeThreads(1, ops, [](int, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                saveDatabaseToFile(BENCH_DATABASE_FILE);
+            }
+        });
+    };
+}
+
+Measure benchLoad(size_t ops) {
+    return [=] {
+        // Each load starts from an empty cache: swap in a pre-cleared map, so freeing
+        // the previous load's entries happens after timing instead of inside it
+        std::vector<std::unordered_map<std::string, std::string>> previous(ops);
+        return timeThreads(1, ops, [&](int, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                cache.swap(previous[i]);
+                loadDatabaseFromFile(BENCH_DATABASE_FILE);
+            }
+        });
+    };
+}
+
+struct BenchCase {
+    BenchResult result;            // Identity of the case; timings filled in at the end
+    std::function<void()> setup;   // Untimed preparation before every sample
+    Measure measure;
+    std::vector<double> samples;   // ns per operation, one per round
+};
+
+std::vector<BenchResult> runBenchmarks(bool quick) {
+    std::vector<size_t> keyCounts = quick ? std::vector<size_t>{100, 1000}
+                                          : std::vector<size_t>{100, 1000, 10000};
+    std::vector<size_t> valueSizes = {16, 256};
+    std::vector<int> threadCounts = quick ? std::vector<int>{1, 2}
+                                          : std::vector<int>{1, 2, 4};
+    const size_t lookupOps = quick ? 50000 : 200000;
+
+    std::vector<BenchCase> cases;
+    auto add = [&](const std::string& stage, size_t keys, size_t valueSize, int threads,
+                   size_t ops, std::function<void()> setup, Measure measure) {
+        cases.push_back({{stage, keys, valueSize, threads, ops, 0, 0, 0}, setup, measure, {}});
+    };
+
+    for (size_t keys : keyCounts) {
+        for (size_t valueSize : valueSizes) {
+            // Every case starts from the labelled cache, whatever the previous case did to it
+            auto populate = [=] { populateCache(keys, valueSize); };
+            auto populateAndSave = [=] {
+                populateCache(keys, valueSize);
+                saveDatabaseToFile(BENCH_DATABASE_FILE);
+            };
+
+            for (int threads : threadCounts) {
+                size_t perThread = lookupOps / threads;
+                add("process_read", keys, valueSize, threads, perThread * threads, populate,
+                    benchRead(keys, threads, perThread));
+                add("cache_lookup", keys, valueSize, threads, perThread * threads, populate,
+                    benchLookup(keys, threads, perThread));
+            }
+
+            // Every update rewrites the whole file, so scale the op count down with the key count
+            size_t fileOps = std::max<size_t>(10, 200000 / keys);
+            add("process_update", keys, valueSize, 1, fileOps, populate, benchUpdate(keys, valueSize, fileOps));
+            add("save", keys, valueSize, 1, fileOps, populate, benchSave(fileOps));
+            add("load", keys, valueSize, 1, fileOps, populateAndSave, benchLoad(fileOps));
+        }
+    }
+
+    // Interleave the samples: each round runs every case once, so a burst of host
+    // noise lands on one sample of many cases rather than on every sample of one
+    for (int round = 0; round <= REPETITIONS; ++round) {
+        for (auto& c : cases) {
+            c.setup();
+            double ns = c.measure();
+            if (round > 0) {  // Round 0 is a warm-up
+                c.samples.push_back(ns / (double)c.result.ops);
+            }
+        }
+        std::cout << "Round " << round << "/" << REPETITIONS << " done\n";
+    }
+
+    std::vector<BenchResult> results;
+    for (auto& c : cases) {
+        Sample sample = summarize(c.samples);
+        c.result.nsPerOp = sample.median;
+        c.result.lowNs = sample.low;
+        c.result.highNs = sample.high;
+        results.push_back(c.result);
+        std::cout << c.result.name() << ": " << sample.median << " ns/op\n";
+    }
+    return results;
+}
+
+void writeResults(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to open " << path << " for writing.\n";
+        return;
+    }
+    out << "name,stage,keys,value_size,threads,ops,ns_per_op,low_ns,high_ns\n";
+    for (const auto& r : results) {
+        out << r.name() << "," << r.stage << "," << r.keys << "," << r.valueSize << ","
+            << r.threads << "," << r.ops << "," << r.nsPerOp << "," << r.lowNs << "," << r.highNs << "\n";
+    }
+}
+
+// Read a results file written by writeResults
+std::vector<BenchResult> readResults(const std::string& path) {
+    std::vector<BenchResult> results;
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);  // Skip header
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields;
+        std::istringstream iss(line);
+        std::string field;
+        while (std::getline(iss, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() == 9) {
+            results.push_back({fields[1], std::strtoul(fields[2].c_str(), nullptr, 10),
+                               std::strtoul(fields[3].c_str(), nullptr, 10), std::atoi(fields[4].c_str()),
+                               std::strtoul(fields[5].c_str(), nullptr, 10), std::atof(fields[6].c_str()),
+                               std::atof(fields[7].c_str()), std::atof(fields[8].c_str())});
+        }
+    }
+    return results;
+}
+
+// Run the benchmark in `processes` fresh invocations of this program and combine the
+// per-process medians of every case: median, fastest and slowest
+std::vector<BenchResult> runProcesses(bool quick, int processes) {
+    std::vector<BenchResult> results;
+    std::map<std::string, std::vector<double>> medians;
+    for (int p = 0; p < processes; ++p) {
+        std::cout << "Process " << p + 1 << "/" << processes << "\n";
+        std::string outPath = "bench_process_" + std::to_string(p) + ".csv";
+        std::vector<std::string> args = {"bench", "--processes", "1", "--out", outPath};
+        if (quick) {
+            args.push_back("--quick");
+        }
+        std::vector<char*> argv;
+        for (auto& arg : args) {
+            argv.push_back(&arg[0]);
+        }
+        argv.push_back(nullptr);
+
+        // The child's per-round progress would drown ours
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        pid_t pid;
+        int status = 0;
+        bool ok = posix_spawn(&pid, "/proc/self/exe", &actions, nullptr, argv.data(), environ) == 0 &&
+                  waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        posix_spawn_file_actions_destroy(&actions);
+        std::vector<BenchResult> run = ok ? readResults(outPath) : std::vector<BenchResult>();
+        std::remove(outPath.c_str());
+        if (run.empty()) {
+            std::cerr << "Benchmark process " << p + 1 << " failed.\n";
+            std::exit(2);
+        }
+
+        for (const auto& r : run) {
+            if (p == 0) {
+                results.push_back(r);
+            }
+            medians[r.name()].push_back(r.nsPerOp);
+        }
+    }
+
+    for (auto& r : results) {
+        std::vector<double>& values = medians[r.name()];
+        std::sort(values.begin(), values.end());
+        r.nsPerOp = values[values.size() / 2];
+        r.lowNs = values.front();
+        r.highNs = values.back();
+        std::cout << r.name() << ": " << r.nsPerOp << " ns/op\n";
+    }
+    return results;
+}
+
+// Report every case against the baseline; return the number of regressions
+int compareWithBaseline(const std::vector<BenchResult>& results,
+                        const std::map<std::string, Sample>& baseline, double thresholdPercent) {
+    int regressions = 0;
+    for (const auto& r : results) {
+        auto it = baseline.find(r.name());
+        if (it == baseline.end() || it->second.median <= 0) {
+            std::cout << "NEW        " << r.name() << "\n";
+            continue;
+        }
+        const Sample& base = it->second;
+        double change = (r.nsPerOp / base.median - 1.0) * 100.0;
+        const char* status = "OK        ";
+        double margin = thresholdPercent / 100.0;
+        if (change > thresholdPercent && r.lowNs > base.high * (1.0 + margin)) {
+            status = "REGRESSION";
+            ++regressions;
+        } else if (change < -thresholdPercent && r.highNs < base.low * (1.0 - margin)) {
+            status = "IMPROVED  ";
+        }
+        char line[256];
+        snprintf(line, sizeof(line), "%s %s: %.1f -> %.1f ns/op (%+.1f%%)",
+                 status, r.name().c_str(), base.median, r.nsPerOp, change);
+        std::cout << line << "\n";
+    }
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    std::string outPath = "bench_results.csv";
+    std::string baselinePath;       // Compare against this file (--baseline)
+    std::string writeBaselinePath;  // Record a new baseline here (--write-baseline)
+    double thresholdPercent = 25.0;
+    int processes = DEFAULT_PROCESSES;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "--write-baseline" && i + 1 < argc) {
+            writeBaselinePath = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            thresholdPercent = std::atof(argv[++i]);
+        } else if (arg == "--processes" && i + 1 < argc && std::atoi(argv[i + 1]) > 0) {
+            processes = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--quick] [--out FILE] [--threshold PERCENT] [--processes N]"
+                      << " [--baseline FILE | --write-baseline FILE]\n";
+            return 2;
+        }
+    }
+    if (!baselinePath.empty() && !writeBaselinePath.empty()) {
+        std::cerr << "--baseline and --write-baseline are mutually exclusive.\n";
+        return 2;
+    }
+
+    // Keep processOperation's writes away from the server's real database file
+    DATABASE_FILE = BENCH_DATABASE_FILE;
+
+    std::vector<BenchResult> results = processes > 1 ? runProcesses(quick, processes) : runBenchmarks(quick);
+    std::remove(BENCH_DATABASE_FILE);
+
+    writeResults(outPath, results);
+    std::cout << "Results written to " << outPath << "\n";
+
+    if (!writeBaselinePath.empty()) {
+        writeResults(writeBaselinePath, results);
+        std::cout << "Baseline written to " << writeBaselinePath << "\n";
+        return 0;
+    }
+    if (baselinePath.empty()) {
+        return 0;
+    }
+
+    std::map<std::string, Sample> baseline;
+    for (const auto& r : readResults(baselinePath)) {
+        baseline[r.name()] = {r.nsPerOp, r.lowNs, r.highNs};
+    }
+    if (baseline.empty()) {
+        std::cerr << "No usable baseline in " << baselinePath << ".\n";
+        return 2;
+    }
+
+    int regressions = compareWithBaseline(results, baseline, thresholdPercent);
+    std::cout << regressions << " regression(s) above " << thresholdPercent << "%\n";
+    return regressions > 0 ? 1 : 0;
+}
@@ -10,6 +10,7 @@
 #include <vector>
 #include <mutex>
 #include <cstring> // For std::strcpy
+#include <cstdlib>
 
 const wchar_t* MEMORY_MAPPED_FILE_NAME = L"MyMappedFile";
 const size_t MAPPED_FILE_SIZE = 1024 * 1024; // 1 MB
@@ -104,12 +105,18 @@ void clientWorker(int clientID, HANDLE hFileMapping) {
     UnmapViewOfFile(sharedData);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Connect to the primary by default, or to read replica N with --replica N
+    std::wstring mappingName = MEMORY_MAPPED_FILE_NAME;
+    if (argc == 3 && std::string(argv[1]) == "--replica") {
+        mappingName += L"_Replica" + std::to_wstring(std::atoi(argv[2]));
+    }
+
     // Create a memory-mapped file for inter-process communication
     HANDLE hFileMapping = OpenFileMappingW(
         FILE_MAP_ALL_ACCESS, // Open for reading and writing
         FALSE,               // Do not inherit the handle
-        MEMORY_MAPPED_FILE_NAME);
+        mappingName.c_str());
 
     if (!hFileMapping) {
         std::cerr << "Failed to open memory-mapped file: " << GetLastError() << "\n";
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <unordered_map>
+#include <string>
+#include <sstream>
+#include <shared_mutex>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "mutation_log.h"
+
+// Database file used by the server to persist the cache
+inline const char* DATABASE_FILE = "database_mmap.txt";
+
+// Counting semaphore used to limit the number of concurrent readers
+class ReaderSemaphore {
+public:
+    explicit ReaderSemaphore(int count) : available(count) {}
+
+    void acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return available > 0; });
+        --available;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++available;
+        }
+        cv.notify_one();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    int available;
+};
+
+// Mutex for synchronization (read-write lock)
+inline std::shared_mutex dbMutex;  // Allows multiple readers, exclusive writer
+
+// In-memory cache (for the database)
+inline std::unordered_map<std::string, std::string> cache;
+
+// Semaphore to limit the number of concurrent readers (maximum 10 readers)
+inline ReaderSemaphore readSemaphore(10);
+
+// Mutation log that successful writes are published to (nullptr when no replica can attach)
+inline MutationLog* mutationLog = nullptr;
+
+// Log epoch this process owns while it is the primary
+inline uint64_t primaryEpoch = 0;
+
+// Set on replicas: writes are rejected and only arrive through the mutation log
+inline bool readOnly = false;
+
+// False once another server has claimed the log; checked under dbMutex before every write
+inline bool ownsMutationLog() {
+    return !mutationLog || mutationLog->epoch.load(std::memory_order_acquire) == primaryEpoch;
+}
+
+// Helper to load the database from file (if necessary)
+inline void loadDatabaseFromFile(const char* path = DATABASE_FILE) {
+    std::ifstream inFile(path);
+    if (!inFile) {
+        std::cerr << "Database file not found. Starting with an empty database.\n";
+        return;
+    }
+
+    std::string key, value;
+    while (std::getline(inFile, key) && std::getline(inFile, value)) {
+        cache[key] = value;  // Populate in-memory cache
+    }
+}
+
+// Atomically replace the file at `path` with the one at `tempPath`
+inline bool replaceFile(const char* tempPath, const char* path) {
+#ifdef _WIN32
+    // A replica that has the old file open blocks the replacement briefly, so retry
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        if (MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+#else
+    return std::rename(tempPath, path) == 0;
+#endif
+}
+
+// Helper to save the database to the file. The cache goes to a temporary file that is then
+// renamed over the database file, so a replica loading it never sees a half-written file.
+// Returns false if the database file was left unchanged.
+inline bool saveDatabaseToFile(const char* path = DATABASE_FILE) {
+    std::string tempPath = std::string(path) + ".tmp";
+    {
+        std::ofstream outFile(tempPath, std::ios::trunc);
+        if (!outFile) {
+            std::cerr << "Failed to open database file for saving.\n";
+            return false;
+        }
+
+        for (const auto& entry : cache) {
+            outFile << entry.first << "\n" << entry.second << "\n";  // Key-value pairs in separate lines
+        }
+        if (!outFile.flush()) {
+            std::cerr << "Failed to write database file.\n";
+            outFile.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+
+    if (!replaceFile(tempPath.c_str(), path)) {
+        std::cerr << "Failed to replace database file.\n";
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Look up a key in the cache; the caller must hold dbMutex
+inline const std::string* lookupCache(const std::string& key) {
+    auto it = cache.find(key);
+    return it != cache.end() ? &it->second : nullptr;
+}
+
+// Process CRUD operations (CREATE, READ, UPDATE, DELETE)
+inline void processOperation(const std::string& operation, char* response) {
+    std::istringstream iss(operation);
+    std::string cmd, key, value;
+
+    iss >> cmd >> key;  // Read command and key
+    if (readOnly && (cmd == "CREATE" || cmd == "UPDATE" || cmd == "DELETE")) {
+        snprintf(response, 512, "ERROR: Read-only replica, send %s to the primary", cmd.c_str());
+    } else if (cmd == "CREATE" || cmd == "UPDATE") {
+        std::getline(iss, value);  // Get the value for CREATE or UPDATE
+        {
+            std::unique_lock<std::shared_mutex> lock(dbMutex);  // Exclusive lock for writing
+            if (!ownsMutationLog()) {
+                snprintf(response, 512, "ERROR: No longer primary, send %s to the new primary", cmd.c_str());
+                return;
+            }
+            auto previous = cache.find(key);
+            bool existed = previous != cache.end();
+            std::string oldValue = existed ? previous->second : std::string();
+            cache[key] = value;  // Modify the in-memory cache
+            if (!saveDatabaseToFile()) {  // Persist the changes to file
+                // Undo the change: replicas and a restart must not see a write that was never saved
+                if (existed) {
+                    cache[key] = oldValue;
+                } else {
+                    cache.erase(key);
+                }
+                snprintf(response, 512, "ERROR: Failed to save %s for %s", cmd.c_str(), key.c_str());
+                return;
+            }
+            if (mutationLog) {
+                appendMutation(mutationLog, operation);  // Publish the change to replicas
+            }
+        }
+        snprintf(response, 512, "SUCCESS: %s for %s", cmd.c_str(), key.c_str());
+    } else if (cmd == "READ") {
+        // Acquire the semaphore (limit the number of concurrent readers)
+        readSemaphore.acquire();  // Block until a semaphore slot is available
+        {
+            std::shared_lock<std::shared_mutex> lock(dbMutex);  // Shared lock for reading
+            if (const std::string* found = lookupCache(key)) {
+                snprintf(response, 512, "READ: %s => %s", key.c_str(), found->c_str());
+            } else {
+                snprintf(response, 512, "ERROR: Key %s not found", key.c_str());
+            }
+        }
+        // Release the semaphore after reading
+        readSemaphore.release();  // Release one slot for another reader
+    } else if (cmd == "DELETE") {
+        {
+            std::unique_lock<std::shared_mutex> lock(dbMutex);  // Exclusive lock for writing
+            if (!ownsMutationLog()) {
+                snprintf(response, 512, "ERROR: No longer primary, send DELETE to the new primary");
+            } else if (auto found = cache.find(key); found != cache.end()) {
+                std::string oldValue = std::move(found->second);
+                cache.erase(found);
+                if (!saveDatabaseToFile()) {  // Persist the changes to file
+                    cache[key] = std::move(oldValue);  // Undo, as for CREATE/UPDATE
+                    snprintf(response, 512, "ERROR: Failed to save DELETE %s", key.c_str());
+                } else {
+                    if (mutationLog) {
+                        appendMutation(mutationLog, operation);  // Publish the change to replicas
+                    }
+                    snprintf(response, 512, "SUCCESS: DELETE %s", key.c_str());
+                }
+            } else {
+                snprintf(response, 512, "ERROR: Key %s not found", key.c_str());
+            }
+        }
+    } else {
+        snprintf(response, 512, "ERROR: Unknown command");
+    }
+}
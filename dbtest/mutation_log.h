@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Shared-memory mutation log: the primary appends every successful write,
+// replicas on the same host tail it to keep their own copy of the cache.
+//
+// The log is a ring of fixed-size records. Each record carries a version
+// used as a per-slot seqlock: 2*seq+1 while the primary is writing it and
+// 2*seq+2 once it is complete. A replica that falls more than
+// MUTATION_LOG_CAPACITY records behind sees a newer version in the slot
+// and must resynchronize from the database file.
+
+const size_t MUTATION_LOG_CAPACITY = 4096;  // Records kept before the oldest is overwritten
+const size_t MUTATION_OPERATION_SIZE = 512; // Same as the request buffer in SharedData
+
+struct MutationRecord {
+    std::atomic<uint64_t> version;         // Seqlock version (see above)
+    uint64_t timestampNs;                  // Time the primary appended the record
+    char operation[MUTATION_OPERATION_SIZE];  // The CREATE/UPDATE/DELETE request as received
+};
+
+struct MutationLog {
+    std::atomic<uint64_t> head;            // Sequence number of the next record to append
+    std::atomic<uint64_t> epoch;           // Bumped every time a server becomes primary
+    std::atomic<uint64_t> heartbeatNs;     // Last time the primary polled for requests
+    std::atomic<uint64_t> steppedDown;     // Epoch of the last primary that acknowledged stepping down
+    MutationRecord records[MUTATION_LOG_CAPACITY];
+};
+
+// Monotonic clock shared by all processes on the host
+inline uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Append an operation to the log; only the primary calls this, under the exclusive dbMutex
+inline void appendMutation(MutationLog* log, const std::string& operation) {
+    uint64_t seq = log->head.load(std::memory_order_relaxed);
+    MutationRecord& record = log->records[seq % MUTATION_LOG_CAPACITY];
+
+    record.version.store(2 * seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    record.timestampNs = nowNs();
+    size_t length = operation.size() < MUTATION_OPERATION_SIZE ? operation.size() : MUTATION_OPERATION_SIZE - 1;
+    std::memcpy(record.operation, operation.data(), length);
+    record.operation[length] = '\0';
+
+    record.version.store(2 * seq + 2, std::memory_order_release);
+    log->head.store(seq + 1, std::memory_order_release);
+}
+
+// Copy record `seq` out of the log; returns false if it has already been overwritten
+inline bool readMutation(const MutationLog* log, uint64_t seq, std::string& operation, uint64_t& timestampNs) {
+    const MutationRecord& record = log->records[seq % MUTATION_LOG_CAPACITY];
+
+    uint64_t version = record.version.load(std::memory_order_acquire);
+    if (version != 2 * seq + 2) {
+        return false;
+    }
+
+    char buffer[MUTATION_OPERATION_SIZE];
+    std::memcpy(buffer, record.operation, sizeof(buffer));
+    timestampNs = record.timestampNs;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (record.version.load(std::memory_order_relaxed) != version) {
+        return false;  // The primary lapped us while we were copying
+    }
+
+    buffer[sizeof(buffer) - 1] = '\0';
+    operation = buffer;
+    return true;
+}
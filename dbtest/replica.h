@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "database.h"
+#include "mutation_log.h"
+
+// Progress of a replica through the primary's mutation log
+struct ReplicaState {
+    std::atomic<uint64_t> applied{0};      // Sequence number of the next record to apply
+    std::atomic<uint64_t> lastDelayNs{0};  // Append-to-apply delay of the last record applied
+    std::atomic<uint64_t> maxDelayNs{0};   // Largest append-to-apply delay seen so far
+    std::atomic<uint64_t> totalDelayNs{0}; // Sum of append-to-apply delays, for the mean
+    std::atomic<uint64_t> appliedRecords{0};  // Records applied from the log (not via reload)
+    std::atomic<uint64_t> resyncs{0};      // Times the replica had to reload from file
+};
+
+// Apply a logged CREATE/UPDATE/DELETE to the local cache (the primary owns the file)
+inline void applyMutation(const std::string& operation) {
+    std::istringstream iss(operation);
+    std::string cmd, key, value;
+
+    iss >> cmd >> key;  // Read command and key
+    std::unique_lock<std::shared_mutex> lock(dbMutex);  // Exclusive lock for writing
+    if (cmd == "CREATE" || cmd == "UPDATE") {
+        std::getline(iss, value);  // Same value parsing as processOperation
+        cache[key] = value;
+    } else if (cmd == "DELETE") {
+        cache.erase(key);
+    }
+}
+
+// Rebuild the cache from the primary's database file and resume tailing at the current head.
+// The primary appends to the log only after the file was saved, and replaces it atomically, so
+// the file loaded here contains at least every record below the head; replaying from the
+// head re-applies some of them, which converges because each record sets or erases a key.
+inline void resyncFromFile(const MutationLog* log, ReplicaState& state) {
+    uint64_t head = log->head.load(std::memory_order_acquire);
+    {
+        std::unique_lock<std::shared_mutex> lock(dbMutex);
+        cache.clear();
+        loadDatabaseFromFile();
+    }
+    state.applied.store(head, std::memory_order_release);
+    state.resyncs++;
+}
+
+// Apply every record published since state.applied; returns the number of records applied
+inline size_t catchUp(const MutationLog* log, ReplicaState& state) {
+    uint64_t head = log->head.load(std::memory_order_acquire);
+    uint64_t seq = state.applied.load(std::memory_order_relaxed);
+    size_t count = 0;
+
+    std::string operation;
+    uint64_t timestampNs;
+    for (; seq < head; ++seq) {
+        if (!readMutation(log, seq, operation, timestampNs)) {
+            std::cerr << "Replica fell behind the mutation log. Reloading the database file.\n";
+            resyncFromFile(log, state);
+            return count;
+        }
+        applyMutation(operation);
+
+        uint64_t delayNs = nowNs() - timestampNs;
+        state.lastDelayNs.store(delayNs, std::memory_order_relaxed);
+        if (delayNs > state.maxDelayNs.load(std::memory_order_relaxed)) {
+            state.maxDelayNs.store(delayNs, std::memory_order_relaxed);
+        }
+        state.totalDelayNs.fetch_add(delayNs, std::memory_order_relaxed);
+        state.appliedRecords.fetch_add(1, std::memory_order_relaxed);
+        state.applied.store(seq + 1, std::memory_order_release);
+        ++count;
+    }
+    return count;
+}
+
+// Number of published records the replica has not applied yet
+inline uint64_t recordsBehind(const MutationLog* log, const ReplicaState& state) {
+    uint64_t head = log->head.load(std::memory_order_acquire);
+    uint64_t applied = state.applied.load(std::memory_order_acquire);
+    return head > applied ? head - applied : 0;
+}
@@ -0,0 +1,261 @@
+// Aggregate read throughput with 1 to 4 replica processes.
+//
+// The parent process plays the primary: it keeps issuing UPDATEs through
+// processOperation, which persists them and appends them to a mutation log
+// in shared memory. Each replica is a forked process that, like server.exe
+// --replica, takes its initial copy from the database file (resyncFromFile)
+// while the primary keeps writing, then tails the log into its own cache
+// (replica.h) while one reader thread issues READs against it.
+// Reported per run: total READs/s across replicas, and the mean and maximum
+// append-to-apply lag. Exit code is 1 if any replica exits abnormally or its
+// cache does not match the primary's file once the log is drained.
+//
+// Build (Linux):  g++ -O2 -std=c++17 -pthread replica_bench.cpp -o replica_bench
+// Run:            ./replica_bench [--keys N] [--seconds S] [--write-interval-us U]
+//                                 [--out FILE]
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "database.h"
+#include "mutation_log.h"
+#include "replica.h"
+
+const char* BENCH_DATABASE_FILE = "replica_bench_database.txt";
+const int MAX_REPLICAS = 4;
+
+// Per-replica results, written by the replica process into shared memory
+struct ReplicaResult {
+    uint64_t reads;
+    uint64_t applied;
+    uint64_t maxDelayNs;
+    uint64_t totalDelayNs;
+    bool converged;    // Replica cache matched the primary's file after draining the log
+};
+
+// Control block shared between the primary and its replicas
+struct BenchControl {
+    std::atomic<int> ready;    // Replicas that have started their tail thread
+    std::atomic<bool> start;
+    std::atomic<bool> stop;
+    ReplicaResult results[MAX_REPLICAS];
+};
+
+void* mapShared(size_t size) {
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::perror("mmap");
+        std::exit(1);
+    }
+    return memory;
+}
+
+std::string makeKey(size_t i) {
+    return "key" + std::to_string(i);
+}
+
+// Body of a forked replica process
+void runReplica(int index, size_t keys, MutationLog* log, BenchControl* control) {
+    readOnly = true;
+    mutationLog = nullptr;
+
+    // Start the same way server.exe --replica does, not from the forked copy of the cache
+    ReplicaState state;
+    cache.clear();
+    resyncFromFile(log, state);
+
+    std::thread tail([&] {
+        while (!control->stop) {
+            if (catchUp(log, state) == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    });
+
+    std::vector<std::string> operations;
+    for (size_t i = 0; i < keys; ++i) {
+        operations.push_back("READ " + makeKey(i));
+    }
+
+    control->ready++;
+    while (!control->start) {
+        std::this_thread::yield();
+    }
+
+    char response[512];
+    uint64_t reads = 0;
+    while (!control->stop) {
+        for (int i = 0; i < 1024; ++i) {
+            processOperation(operations[(reads + i) % keys], response);
+        }
+        reads += 1024;
+    }
+    tail.join();
+
+    // The primary has stopped writing: drain the log and check the copy against its file
+    catchUp(log, state);
+    auto replicaCache = cache;
+    cache.clear();
+    loadDatabaseFromFile();
+    bool converged = replicaCache == cache;
+
+    control->results[index] = {reads, state.appliedRecords.load(), state.maxDelayNs.load(),
+                               state.totalDelayNs.load(), converged};
+}
+
+int main(int argc, char** argv) {
+    size_t keys = 1000;
+    double seconds = 2.0;
+    int writeIntervalUs = 1000;
+    std::string outPath = "replica_bench_results.csv";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--keys" && i + 1 < argc) {
+            keys = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        } else if (arg == "--write-interval-us" && i + 1 < argc) {
+            writeIntervalUs = std::atoi(argv[++i]);
+        } else if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--keys N] [--seconds S]"
+                      << " [--write-interval-us U] [--out FILE]\n";
+            return 2;
+        }
+    }
+    if (keys == 0) {
+        keys = 1;
+    }
+
+    // Primary setup: populate and persist the store, then publish writes to the log
+    DATABASE_FILE = BENCH_DATABASE_FILE;
+    for (size_t i = 0; i < keys; ++i) {
+        cache[makeKey(i)] = " value_" + std::to_string(i);
+    }
+    if (!saveDatabaseToFile()) {
+        return 1;
+    }
+
+    MutationLog* log = new (mapShared(sizeof(MutationLog))) MutationLog();
+    BenchControl* control = new (mapShared(sizeof(BenchControl))) BenchControl();
+    mutationLog = log;
+
+    std::ofstream out(outPath, std::ios::trunc);
+    out << "replicas,keys,seconds,writes,reads_per_sec,reads_per_sec_per_replica,mean_lag_us,max_lag_us\n";
+
+    bool failed = false;
+    for (int replicas = 1; replicas <= MAX_REPLICAS; ++replicas) {
+        control->ready = 0;
+        control->start = false;
+        control->stop = false;
+        for (auto& result : control->results) {
+            result = {};  // A replica that dies must not report the previous run's results
+        }
+
+        std::vector<pid_t> children;
+        for (int r = 0; r < replicas; ++r) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                runReplica(r, keys, log, control);
+                _exit(0);
+            }
+            if (pid < 0) {
+                std::perror("fork");
+                return 1;
+            }
+            children.push_back(pid);
+        }
+
+        // Reap a replica that has exited; `exitOk` records whether it exited cleanly
+        std::vector<bool> reaped(replicas, false), exitOk(replicas, false);
+        auto reap = [&](int r, int options) {
+            int status = 0;
+            if (!reaped[r] && waitpid(children[r], &status, options) == children[r]) {
+                reaped[r] = true;
+                exitOk[r] = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            }
+        };
+
+        // Drive a steady stream of writes, starting while the replicas load the file;
+        // the timed window begins once every replica is ready or has died
+        char response[512];
+        uint64_t writes = 0;
+        uint64_t timedWrites = 0;
+        auto begin = std::chrono::steady_clock::now();
+        auto deadline = begin;
+        while (!control->start || std::chrono::steady_clock::now() < deadline) {
+            int exitedEarly = 0;
+            for (int r = 0; !control->start && r < replicas; ++r) {
+                reap(r, WNOHANG);
+                exitedEarly += reaped[r] ? 1 : 0;
+            }
+            if (!control->start && control->ready + exitedEarly >= replicas) {
+                control->start = true;
+                begin = std::chrono::steady_clock::now();
+                deadline = begin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(seconds));
+            }
+            std::string operation = "UPDATE " + makeKey(writes % keys) + " value_w" + std::to_string(writes);
+            processOperation(operation, response);
+            ++writes;
+            timedWrites += control->start ? 1 : 0;
+            std::this_thread::sleep_for(std::chrono::microseconds(writeIntervalUs));
+        }
+        control->stop = true;
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        for (int r = 0; r < replicas; ++r) {
+            reap(r, 0);
+        }
+
+        uint64_t totalReads = 0, totalApplied = 0, totalDelayNs = 0, maxDelayNs = 0;
+        for (int r = 0; r < replicas; ++r) {
+            const ReplicaResult& result = control->results[r];
+            if (!exitOk[r]) {
+                std::cerr << "Replica " << r + 1 << " exited abnormally.\n";
+                failed = true;
+                continue;
+            }
+            if (!result.converged) {
+                std::cerr << "Replica " << r + 1 << " diverged from the primary.\n";
+                failed = true;
+            }
+            totalReads += result.reads;
+            totalApplied += result.applied;
+            totalDelayNs += result.totalDelayNs;
+            if (result.maxDelayNs > maxDelayNs) {
+                maxDelayNs = result.maxDelayNs;
+            }
+        }
+
+        double readsPerSec = totalReads / elapsed;
+        double meanLagUs = totalApplied ? totalDelayNs / 1e3 / totalApplied : 0.0;
+        double maxLagUs = maxDelayNs / 1e3;
+
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "replicas=%d: %.0f reads/s total, %.0f reads/s per replica, %llu writes, lag mean %.1f us max %.1f us",
+                 replicas, readsPerSec, readsPerSec / replicas, (unsigned long long)timedWrites, meanLagUs, maxLagUs);
+        std::cout << line << "\n";
+        out << replicas << "," << keys << "," << elapsed << "," << timedWrites << "," << readsPerSec << ","
+            << readsPerSec / replicas << "," << meanLagUs << "," << maxLagUs << "\n";
+    }
+
+    std::remove(BENCH_DATABASE_FILE);
+    std::cout << "Results written to " << outPath << "\n";
+    return failed ? 1 : 0;
+}
@@ -1,18 +1,20 @@
 #include <windows.h>
 #include <iostream>
-#include <fstream>
-#include <unordered_map>
 #include <string>
-#include <sstream>
-#include <shared_mutex>
-#include <mutex>
-#include <chrono>
+#include <vector>
 #include <thread>
+#include <atomic>
+#include <cstdlib>
 
-// Constants for memory-mapped file and database file
+#include "database.h"
+#include "mutation_log.h"
+#include "replica.h"
+
+// Constants for memory-mapped file and mutation log
 const wchar_t* MEMORY_MAPPED_FILE_NAME = L"MyMappedFile";
-const char* DATABASE_FILE = "database_mmap.txt";
+const wchar_t* MUTATION_LOG_NAME = L"MyMutationLog";
 const size_t MAPPED_FILE_SIZE = 1024 * 1024; // 1 MB
+const double PRIMARY_HEARTBEAT_TIMEOUT_MS = 2000; // A primary silent this long is presumed dead
 
 // Shared data structure for communication via memory-mapped file
 struct SharedData {
@@ -22,139 +24,211 @@ struct SharedData {
     bool responseReady;
 };
 
-// Mutex for synchronization (read-write lock)
-std::shared_mutex dbMutex;  // Allows multiple readers, exclusive writer
+// A request/response channel backed by a named memory-mapped file
+struct Channel {
+    HANDLE hFileMapping;
+    SharedData* sharedData;
+};
 
-// In-memory cache (for the database)
-std::unordered_map<std::string, std::string> cache;
+MutationLog* sharedLog = nullptr;   // Mutation log view (primary appends, replicas tail)
+ReplicaState replicaState;          // Replica progress through the log
+std::atomic<bool> tailing{false};   // Keeps the replica's tail thread running
+std::thread tailThread;
 
-// Semaphore to limit the number of concurrent readers (maximum 10 readers)
-HANDLE readSemaphore;  // Semaphore to control the number of concurrent readers
+// Name of the channel a replica serves reads on, e.g. MyMappedFile_Replica1
+std::wstring replicaMappingName(int replicaId) {
+    return std::wstring(MEMORY_MAPPED_FILE_NAME) + L"_Replica" + std::to_wstring(replicaId);
+}
 
-// Helper to load the database from file (if necessary)
-void loadDatabaseFromFile() {
-    std::ifstream inFile(DATABASE_FILE);
-    if (!inFile) {
-        std::cerr << "Database file not found. Starting with an empty database.\n";
-        return;
+// Create (or open, if it already exists) a named channel and map it
+bool openChannel(const wchar_t* name, Channel& channel) {
+    channel.hFileMapping = CreateFileMappingW(
+        INVALID_HANDLE_VALUE,
+        nullptr,
+        PAGE_READWRITE,
+        0,
+        MAPPED_FILE_SIZE,
+        name);
+
+    if (!channel.hFileMapping) {
+        std::cerr << "Failed to create memory-mapped file: " << GetLastError() << "\n";
+        return false;
     }
 
-    std::string key, value;
-    while (std::getline(inFile, key) && std::getline(inFile, value)) {
-        cache[key] = value;  // Populate in-memory cache
+    channel.sharedData = (SharedData*)MapViewOfFile(channel.hFileMapping, FILE_MAP_ALL_ACCESS, 0, 0, MAPPED_FILE_SIZE);
+    if (!channel.sharedData) {
+        std::cerr << "Failed to map view of file: " << GetLastError() << "\n";
+        CloseHandle(channel.hFileMapping);
+        return false;
     }
+    return true;
 }
 
-// Helper to save the database to the file
-void saveDatabaseToFile() {
-    std::ofstream outFile(DATABASE_FILE, std::ios::trunc);
-    if (!outFile) {
-        std::cerr << "Failed to open database file for saving.\n";
-        return;
+// Replica background thread: apply the primary's mutations as they are published
+void tailLog() {
+    while (tailing) {
+        if (catchUp(sharedLog, replicaState) == 0) {
+            Sleep(1);  // Nothing new, avoid busy-waiting
+        }
     }
+}
 
-    for (const auto& entry : cache) {
-        outFile << entry.first << "\n" << entry.second << "\n";  // Key-value pairs in separate lines
+// Claim the next log epoch, then wait until the previous primary has stopped serving:
+// either it acknowledged the new epoch between requests, or its heartbeat went stale.
+// After this returns, nothing else appends to the log or polls the primary channel.
+void claimPrimary() {
+    primaryEpoch = sharedLog->epoch.fetch_add(1) + 1;
+    while (sharedLog->steppedDown.load() + 1 < primaryEpoch) {
+        double heartbeatAgeMs = (nowNs() - sharedLog->heartbeatNs.load()) / 1e6;
+        if (heartbeatAgeMs > PRIMARY_HEARTBEAT_TIMEOUT_MS) {
+            break;
+        }
+        Sleep(10);
     }
 }
 
-// Process CRUD operations (CREATE, READ, UPDATE, DELETE)
-void processOperation(const std::string& operation, char* response) {
-    std::istringstream iss(operation);
-    std::string cmd, key, value;
-
-    iss >> cmd >> key;  // Read command and key
-    if (cmd == "CREATE" || cmd == "UPDATE") {
-        std::getline(iss, value);  // Get the value for CREATE or UPDATE
-        {
-            std::unique_lock<std::shared_mutex> lock(dbMutex);  // Exclusive lock for writing
-            cache[key] = value;  // Modify the in-memory cache
-            saveDatabaseToFile();  // Persist the changes to file
-        }
-        snprintf(response, 512, "SUCCESS: %s for %s", cmd.c_str(), key.c_str());
-    } else if (cmd == "READ") {
-        // Acquire the semaphore (limit the number of concurrent readers)
-        WaitForSingleObject(readSemaphore, INFINITE);  // Block until a semaphore slot is available
-        {
-            std::shared_lock<std::shared_mutex> lock(dbMutex);  // Shared lock for reading
-            if (cache.find(key) != cache.end()) {
-                snprintf(response, 512, "READ: %s => %s", key.c_str(), cache[key].c_str());
-            } else {
-                snprintf(response, 512, "ERROR: Key %s not found", key.c_str());
-            }
+// Start publishing to the log and take over the primary channel, keeping the current cache
+void promoteToPrimary(std::vector<Channel>& channels) {
+    tailing = false;
+    tailThread.join();
+
+    claimPrimary();
+    catchUp(sharedLog, replicaState);  // Drain everything the old primary published
+
+    mutationLog = sharedLog;
+    readOnly = false;
+
+    Channel primary;
+    if (openChannel(MEMORY_MAPPED_FILE_NAME, primary)) {
+        channels.push_back(primary);
+    }
+}
+
+// Handle server-level commands (LAG, PROMOTE); returns false for ordinary CRUD requests
+bool processServerCommand(const std::string& operation, char* response, std::vector<Channel>& channels) {
+    if (operation == "LAG") {
+        if (mutationLog) {
+            snprintf(response, 512, "LAG: primary, %llu records published",
+                     (unsigned long long)sharedLog->head.load());
+        } else {
+            uint64_t applied = replicaState.appliedRecords.load();
+            double meanDelayUs = applied ? replicaState.totalDelayNs.load() / 1e3 / applied : 0.0;
+            double heartbeatAgeMs = (nowNs() - sharedLog->heartbeatNs.load()) / 1e6;
+            snprintf(response, 512,
+                     "LAG: %llu records behind, last apply %.1f us, mean %.1f us, max %.1f us, primary heartbeat %.0f ms ago",
+                     (unsigned long long)recordsBehind(sharedLog, replicaState),
+                     replicaState.lastDelayNs.load() / 1e3,
+                     meanDelayUs,
+                     replicaState.maxDelayNs.load() / 1e3,
+                     heartbeatAgeMs);
         }
-        // Release the semaphore after reading
-        ReleaseSemaphore(readSemaphore, 1, nullptr);  // Release one slot for another reader
-    } else if (cmd == "DELETE") {
-        {
-            std::unique_lock<std::shared_mutex> lock(dbMutex);  // Exclusive lock for writing
-            if (cache.erase(key)) {
-                saveDatabaseToFile();  // Persist the changes to file
-                snprintf(response, 512, "SUCCESS: DELETE %s", key.c_str());
-            } else {
-                snprintf(response, 512, "ERROR: Key %s not found", key.c_str());
-            }
+        return true;
+    }
+    if (operation == "PROMOTE") {
+        if (mutationLog) {
+            snprintf(response, 512, "ERROR: Already primary");
+        } else {
+            promoteToPrimary(channels);
+            snprintf(response, 512, "SUCCESS: Promoted to primary (epoch %llu)", (unsigned long long)primaryEpoch);
         }
-    } else {
-        snprintf(response, 512, "ERROR: Unknown command");
+        return true;
     }
+    return false;
 }
 
-int main() {
-    // Create a memory-mapped file for inter-process communication
-    HANDLE hFileMapping = CreateFileMappingW(
-        INVALID_HANDLE_VALUE,
-        nullptr,
-        PAGE_READWRITE,
-        0,
-        MAPPED_FILE_SIZE,
-        MEMORY_MAPPED_FILE_NAME);
-
-    if (!hFileMapping) {
-        std::cerr << "Failed to create memory-mapped file: " << GetLastError() << "\n";
-        return 1;
+int main(int argc, char* argv[]) {
+    // Run as the primary by default, or as read replica N with --replica N
+    int replicaId = 0;
+    if (argc == 3 && std::string(argv[1]) == "--replica") {
+        replicaId = std::atoi(argv[2]);
     }
-
-    SharedData* sharedData = (SharedData*)MapViewOfFile(hFileMapping, FILE_MAP_ALL_ACCESS, 0, 0, MAPPED_FILE_SIZE);
-    if (!sharedData) {
-        std::cerr << "Failed to map view of file: " << GetLastError() << "\n";
-        CloseHandle(hFileMapping);
+    if (argc != 1 && replicaId <= 0) {
+        std::cerr << "Usage: server.exe [--replica N]\n";
         return 1;
     }
 
-    // Load the initial database from file to memory (cache)
-    loadDatabaseFromFile();
+    // The primary creates the mutation log, replicas attach to it
+    HANDLE hLogMapping = replicaId
+        ? OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, MUTATION_LOG_NAME)
+        : CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(MutationLog), MUTATION_LOG_NAME);
 
-    // Create a semaphore to limit the number of concurrent readers (maximum 10)
-    readSemaphore = CreateSemaphore(
-        nullptr,            // No security attributes
-        10,                 // Initial count (allow 10 concurrent readers)
-        10,                 // Maximum count (maximum 10 concurrent readers)
-        nullptr);           // No name for the semaphore
+    if (!hLogMapping) {
+        std::cerr << "Failed to open mutation log (is the primary running?): " << GetLastError() << "\n";
+        return 1;
+    }
 
-    if (readSemaphore == nullptr) {
-        std::cerr << "Failed to create semaphore: " << GetLastError() << "\n";
+    sharedLog = (MutationLog*)MapViewOfFile(hLogMapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(MutationLog));
+    if (!sharedLog) {
+        std::cerr << "Failed to map mutation log: " << GetLastError() << "\n";
+        CloseHandle(hLogMapping);
         return 1;
     }
 
-    std::cout << "Database server running. Waiting for requests...\n";
+    // Create a memory-mapped file for inter-process communication
+    std::vector<Channel> channels;
+    Channel channel;
+    std::wstring channelName = replicaId ? replicaMappingName(replicaId) : MEMORY_MAPPED_FILE_NAME;
+    if (!openChannel(channelName.c_str(), channel)) {
+        UnmapViewOfFile(sharedLog);
+        CloseHandle(hLogMapping);
+        return 1;
+    }
+    channels.push_back(channel);
+
+    if (replicaId) {
+        // Take the initial copy from the primary's file, then follow the log
+        readOnly = true;
+        resyncFromFile(sharedLog, replicaState);
+        tailing = true;
+        tailThread = std::thread(tailLog);
+        std::cout << "Replica " << replicaId << " running. Waiting for requests...\n";
+    } else {
+        // Wait out any running primary, then load the database from file to memory (cache)
+        claimPrimary();
+        loadDatabaseFromFile();
+        mutationLog = sharedLog;
+        std::cout << "Database server running. Waiting for requests...\n";
+    }
 
     while (true) {
-        if (sharedData->requestReady) {
-            sharedData->requestReady = false;  // Mark request as processed
+        if (mutationLog) {
+            if (sharedLog->epoch.load() != primaryEpoch) {
+                // Acknowledge between requests, so none of our writes lands after the new primary drains
+                sharedLog->steppedDown = primaryEpoch;
+                std::cout << "Another server was promoted to primary. Shutting down.\n";
+                break;
+            }
+            sharedLog->heartbeatNs = nowNs();
+        }
+
+        // Index loop: PROMOTE adds the primary channel while we iterate
+        for (size_t i = 0; i < channels.size(); ++i) {
+            SharedData* sharedData = channels[i].sharedData;
+            if (sharedData->requestReady) {
+                sharedData->requestReady = false;  // Mark request as processed
 
-            // Process the operation and provide a response
-            processOperation(sharedData->request, sharedData->response);
+                // Process the operation and provide a response
+                if (!processServerCommand(sharedData->request, sharedData->response, channels)) {
+                    processOperation(sharedData->request, sharedData->response);
+                }
 
-            sharedData->responseReady = true;  // Notify the client that the response is ready
+                sharedData->responseReady = true;  // Notify the client that the response is ready
+            }
         }
         Sleep(10);  // Avoid busy-waiting
     }
 
     // Clean up
-    UnmapViewOfFile(sharedData);
-    CloseHandle(hFileMapping);
-    CloseHandle(readSemaphore);  // Close the semaphore handle
+    if (tailThread.joinable()) {
+        tailing = false;
+        tailThread.join();
+    }
+    for (auto& c : channels) {
+        UnmapViewOfFile(c.sharedData);
+        CloseHandle(c.hFileMapping);
+    }
+    UnmapViewOfFile(sharedLog);
+    CloseHandle(hLogMapping);
 
     return 0;
 }
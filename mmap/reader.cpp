@@ -1,14 +1,159 @@
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0602  // Windows 8, for PrefetchVirtualMemory
+#endif
 #include <windows.h>
 #include <iostream>
 #include <chrono>
 
+#include "window.h"
+
 #define SHARED_MEMORY_NAME L"MySharedMemory"
 #define DATA_SIZE 1024 * 1024 * 10  // 10 MB
 #define MUTEX_NAME L"MySharedMemoryMutex"
 #define SEM_READER_DONE_NAME L"ReaderDoneSemaphore"
 #define SEM_WRITER_READY_NAME L"WriterReadySemaphore"
 
-int main() {
+// File-backed mode: follow the writer window by window, unmapping each one once it is read
+int readFileBacked(const WindowOptions& options) {
+    HANDLE hSemWindowReady = OpenSemaphoreW(SYNCHRONIZE, FALSE, SEM_WINDOW_READY_NAME);
+    HANDLE hSemReaderDone = OpenSemaphoreW(SEMAPHORE_MODIFY_STATE, FALSE, SEM_READER_DONE_NAME);
+    HANDLE hAborted = OpenEventW(SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, EVENT_TRANSFER_ABORTED_NAME);
+
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    HANDLE hMapFile = nullptr;
+
+    // Every failure path goes through here: wake the writer, which would otherwise
+    // wait for us forever, and close whatever is open
+    auto abortTransfer = [&] {
+        if (hAborted) {
+            SetEvent(hAborted);
+            CloseHandle(hAborted);
+        }
+        if (hSemWindowReady) CloseHandle(hSemWindowReady);
+        if (hSemReaderDone) CloseHandle(hSemReaderDone);
+        if (hMapFile) CloseHandle(hMapFile);
+        if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+        return 1;
+    };
+
+    if (!hSemWindowReady || !hSemReaderDone || !hAborted) {
+        std::cerr << "Could not open synchronization objects: " << GetLastError() << "\n";
+        return abortTransfer();
+    }
+
+    // Follow the writer's window size rather than our own command line
+    TransferInfo info;
+    if (!readTransferInfo(info)) {
+        std::cerr << "Could not read transfer info: " << GetLastError() << "\n";
+        return abortTransfer();
+    }
+    uint64_t size = info.size;
+    uint64_t window = info.window;
+
+    // The writer has already sized the file when it created the semaphores
+    hFile = CreateFileW(options.path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize;
+    if (hFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(hFile, &fileSize) || (uint64_t)fileSize.QuadPart < size) {
+        std::cerr << "Could not open backing file of " << (size >> 20) << " MB: " << GetLastError() << "\n";
+        return abortTransfer();
+    }
+
+    hMapFile = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapFile) {
+        std::cerr << "Could not create file mapping: " << GetLastError() << "\n";
+        return abortTransfer();
+    }
+
+    ThroughputReporter report("read");
+    uint64_t checksum = 0;
+    auto windowLength = [&](uint64_t offset) { return size - offset < window ? size - offset : window; };
+    auto mapReadWindow = [&](uint64_t offset) {
+        char* pBuf = mapWindow(hMapFile, FILE_MAP_READ, offset, windowLength(offset));
+        if (!pBuf) {
+            std::cerr << "Could not map window at offset " << offset << ": " << GetLastError() << "\n";
+        }
+        return pBuf;
+    };
+
+    // Read-ahead: while window N is read, window N+1 is already mapped and its pages are
+    // being brought in by PrefetchVirtualMemory. It is only taken early if the writer has
+    // released it; a window we had to wait for was just written and is still in memory.
+    char* pNext = nullptr;
+    bool aborted = false;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint64_t offset = 0; offset < size; offset += window) {
+        uint64_t length = windowLength(offset);
+        char* pBuf = pNext;
+        pNext = nullptr;
+        if (!pBuf) {
+            if (!waitUnlessAborted(hSemWindowReady, hAborted)) {  // Wait until the writer finished this window
+                std::cerr << "Writer aborted the transfer at offset " << offset << ".\n";
+                aborted = true;
+                break;
+            }
+            pBuf = mapReadWindow(offset);
+            if (!pBuf) {
+                aborted = true;
+                break;
+            }
+        }
+
+        uint64_t nextOffset = offset + window;
+        if (nextOffset < size && WaitForSingleObject(hSemWindowReady, 0) == WAIT_OBJECT_0) {
+            pNext = mapReadWindow(nextOffset);
+            if (!pNext) {
+                UnmapViewOfFile(pBuf);
+                aborted = true;
+                break;
+            }
+            WIN32_MEMORY_RANGE_ENTRY range;
+            range.VirtualAddress = pNext;
+            range.NumberOfBytes = (SIZE_T)windowLength(nextOffset);
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+        }
+
+        for (uint64_t i = 0; i < length; i += sizeof(uint64_t)) {
+            checksum += *(volatile uint64_t*)(pBuf + i);  // Simulate reading
+        }
+        UnmapViewOfFile(pBuf);  // Drop the window behind us
+        report.add(length);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    if (aborted) {
+        return abortTransfer();
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    std::cout << "Data read from " << (size >> 20) << " MB backing file (checksum " << checksum << ").\n";
+    std::cout << "Time taken to read data: " << ms << " ms ("
+              << (ms ? (size >> 20) * 1000 / ms : 0) << " MB/s)\n";
+
+    // Signal the writer that reading is done
+    if (ReleaseSemaphore(hSemReaderDone, 1, nullptr))
+        std::cout << "Finish reading from reader" << std::endl;
+
+    // Cleanup
+    CloseHandle(hSemWindowReady);
+    CloseHandle(hSemReaderDone);
+    CloseHandle(hAborted);
+    CloseHandle(hMapFile);
+    CloseHandle(hFile);
+
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // reader.exe --file PATH follows a file-backed writer, using the writer's window size
+    if (argc > 1) {
+        WindowOptions options;
+        if (!parseWindowOptions(argc, argv, options, false)) {
+            std::cerr << "Usage: reader.exe [--file PATH]\n";
+            return 1;
+        }
+        return readFileBacked(options);
+    }
+
     // Open shared memory
     HANDLE hMapFile = OpenFileMappingW(FILE_MAP_READ, FALSE, SHARED_MEMORY_NAME);
     if (!hMapFile) {
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <windows.h>
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+
+// File-backed windowed mode shared by writer.cpp and reader.cpp: the payload
+// lives in a file on disk and only one window of it is mapped at a time, so
+// the transfer size is bounded by the disk instead of memory.
+
+#define SEM_WINDOW_READY_NAME L"WindowReadySemaphore"
+#define TRANSFER_INFO_NAME L"WindowTransferInfo"
+#define EVENT_TRANSFER_ABORTED_NAME L"TransferAbortedEvent"  // Set by either side when it gives up
+#define DEFAULT_WINDOW_SIZE (64ULL * 1024 * 1024)  // 64 MB
+#define REPORT_INTERVAL (1024ULL * 1024 * 1024)    // Print throughput every 1 GB
+
+struct WindowOptions {
+    std::wstring path;                    // Backing file
+    uint64_t size = 0;                    // Payload size (writer only)
+    uint64_t window = DEFAULT_WINDOW_SIZE;  // Bytes mapped at a time (writer only)
+};
+
+// Published by the writer in a small named mapping, so the reader maps exactly
+// the windows the writer releases
+struct TransferInfo {
+    uint64_t size;    // Payload size
+    uint64_t window;  // Window size, already aligned
+};
+
+// Parse a whole byte count with an optional K, M or G suffix, e.g. "256M" or "8G".
+// Returns false for anything else ("1.5G", "64X", "-1", "8GB") or a count that overflows
+inline bool parseSize(const char* text, uint64_t& value) {
+    if (*text < '0' || *text > '9') {
+        return false;  // strtoull would accept leading spaces and a sign
+    }
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtoull(text, &end, 10);
+    if (errno == ERANGE) {
+        return false;
+    }
+
+    int shift = 0;
+    switch (*end) {
+    case 'K': case 'k': shift = 10; ++end; break;
+    case 'M': case 'm': shift = 20; ++end; break;
+    case 'G': case 'g': shift = 30; ++end; break;
+    }
+    if (*end != '\0' || value > (UINT64_MAX >> shift)) {
+        return false;
+    }
+    value <<= shift;
+    return true;
+}
+
+// Parse "--file PATH [--size BYTES] [--window BYTES]"; the reader only accepts --file.
+// Returns false if no file was given, an option is not allowed, lacks its value or
+// has a malformed size
+inline bool parseWindowOptions(int argc, char* argv[], WindowOptions& options, bool writer) {
+    if (argc % 2 == 0) {
+        return false;  // Every option takes exactly one value
+    }
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--file") {
+            std::string path = argv[i + 1];
+            options.path.assign(path.begin(), path.end());
+        } else if (arg == "--size" && writer) {
+            if (!parseSize(argv[i + 1], options.size)) {
+                return false;
+            }
+        } else if (arg == "--window" && writer) {
+            if (!parseSize(argv[i + 1], options.window)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return !options.path.empty() && options.window > 0;
+}
+
+// View offsets must be multiples of the allocation granularity (usually 64 KB)
+inline uint64_t alignWindow(uint64_t window) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    uint64_t granularity = info.dwAllocationGranularity;
+    return (window + granularity - 1) / granularity * granularity;
+}
+
+// Map bytes [offset, offset + length) of a file mapping
+inline char* mapWindow(HANDLE hMapFile, DWORD access, uint64_t offset, uint64_t length) {
+    return (char*)MapViewOfFile(hMapFile, access, (DWORD)(offset >> 32), (DWORD)(offset & 0xFFFFFFFF), (SIZE_T)length);
+}
+
+// Create the named TransferInfo mapping; the writer keeps the handle open for the transfer
+inline HANDLE publishTransferInfo(uint64_t size, uint64_t window) {
+    HANDLE hInfo = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(TransferInfo), TRANSFER_INFO_NAME);
+    if (!hInfo) {
+        return nullptr;
+    }
+    TransferInfo* info = (TransferInfo*)MapViewOfFile(hInfo, FILE_MAP_WRITE, 0, 0, sizeof(TransferInfo));
+    if (!info) {
+        CloseHandle(hInfo);
+        return nullptr;
+    }
+    info->size = size;
+    info->window = window;
+    UnmapViewOfFile(info);
+    return hInfo;
+}
+
+// Read the TransferInfo published by the writer; returns false if there is none
+inline bool readTransferInfo(TransferInfo& info) {
+    HANDLE hInfo = OpenFileMappingW(FILE_MAP_READ, FALSE, TRANSFER_INFO_NAME);
+    if (!hInfo) {
+        return false;
+    }
+    const TransferInfo* published = (const TransferInfo*)MapViewOfFile(hInfo, FILE_MAP_READ, 0, 0, sizeof(TransferInfo));
+    if (published) {
+        info = *published;
+        UnmapViewOfFile(published);
+    }
+    CloseHandle(hInfo);
+    return published != nullptr;
+}
+
+// Wait for `handle` unless the other side aborts first; returns false on abort
+inline bool waitUnlessAborted(HANDLE handle, HANDLE hAborted) {
+    HANDLE handles[2] = {handle, hAborted};
+    return WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0;
+}
+
+// Prints the throughput of every REPORT_INTERVAL bytes, so a slowdown as the
+// payload grows past physical memory is visible
+class ThroughputReporter {
+public:
+    explicit ThroughputReporter(const char* verb) : verb(verb), intervalStart(std::chrono::high_resolution_clock::now()) {}
+
+    void add(uint64_t bytes) {
+        total += bytes;
+        intervalBytes += bytes;
+        if (intervalBytes >= REPORT_INTERVAL) {
+            auto now = std::chrono::high_resolution_clock::now();
+            double seconds = std::chrono::duration<double>(now - intervalStart).count();
+            std::cout << "  " << (total >> 20) << " MB " << verb << ", "
+                      << (uint64_t)((intervalBytes >> 20) / seconds) << " MB/s over the last "
+                      << (intervalBytes >> 20) << " MB\n";
+            intervalBytes = 0;
+            intervalStart = now;
+        }
+    }
+
+private:
+    const char* verb;
+    uint64_t total = 0;
+    uint64_t intervalBytes = 0;
+    std::chrono::high_resolution_clock::time_point intervalStart;
+};
@@ -2,13 +2,133 @@
 #include <iostream>
 #include <chrono>
 
+#include "window.h"
+
 #define SHARED_MEMORY_NAME L"MySharedMemory"
 #define DATA_SIZE 1024 * 1024 * 10  // 10 MB
 #define MUTEX_NAME L"MySharedMemoryMutex"
 #define SEM_READER_DONE_NAME L"ReaderDoneSemaphore"
 #define SEM_WRITER_READY_NAME L"WriterReadySemaphore"
 
-int main() {
+// File-backed mode: stream the payload through a sliding window of the file,
+// so it can exceed physical memory and outlives the writer
+int writeFileBacked(const WindowOptions& options) {
+    uint64_t size = options.size;
+    uint64_t window = alignWindow(options.window);
+
+    HANDLE hFile = CreateFileW(options.path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                               nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::cerr << "Could not create backing file: " << GetLastError() << "\n";
+        return 1;
+    }
+
+    // Mapping the full size extends the file, so the reader sees the final size up front
+    HANDLE hMapFile = CreateFileMappingW(hFile, nullptr, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)(size & 0xFFFFFFFF), nullptr);
+    if (!hMapFile) {
+        std::cerr << "Could not create file mapping: " << GetLastError() << "\n";
+        CloseHandle(hFile);
+        return 1;
+    }
+
+    // Publish the layout before the semaphores, so a reader that can open them can also read it
+    HANDLE hInfo = publishTransferInfo(size, window);
+    if (!hInfo) {
+        std::cerr << "Could not publish transfer info: " << GetLastError() << "\n";
+        CloseHandle(hMapFile);
+        CloseHandle(hFile);
+        return 1;
+    }
+
+    // One release per finished window; the reader follows behind
+    HANDLE hSemWindowReady = CreateSemaphoreW(nullptr, 0, 0x7FFFFFFF, SEM_WINDOW_READY_NAME);
+    HANDLE hSemReaderDone = CreateSemaphoreW(nullptr, 0, 1, SEM_READER_DONE_NAME);
+    HANDLE hAborted = CreateEventW(nullptr, TRUE, FALSE, EVENT_TRANSFER_ABORTED_NAME);  // Manual reset, wakes every waiter
+
+    if (!hSemWindowReady || !hSemReaderDone || !hAborted) {
+        std::cerr << "Could not create synchronization objects: " << GetLastError() << "\n";
+        CloseHandle(hInfo);
+        CloseHandle(hMapFile);
+        CloseHandle(hFile);
+        return 1;
+    }
+
+    std::cout << "Writing " << (size >> 20) << " MB in " << (window >> 20) << " MB windows.\n";
+    ThroughputReporter report("written");
+    bool aborted = false;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint64_t offset = 0; offset < size; offset += window) {
+        if (WaitForSingleObject(hAborted, 0) == WAIT_OBJECT_0) {
+            std::cerr << "Reader aborted the transfer at offset " << offset << ".\n";
+            aborted = true;
+            break;
+        }
+
+        uint64_t length = size - offset < window ? size - offset : window;
+        char* pBuf = mapWindow(hMapFile, FILE_MAP_WRITE, offset, length);
+        if (!pBuf) {
+            std::cerr << "Could not map window at offset " << offset << ": " << GetLastError() << "\n";
+            SetEvent(hAborted);  // Wake the reader instead of leaving it waiting for this window
+            aborted = true;
+            break;
+        }
+
+        memset(pBuf, 'A', (size_t)length);  // Fill the window with data
+        // No FlushViewOfFile here: it returns only once the window is on disk, which would
+        // serialize every disk write into this loop. The unmapped pages stay dirty in the
+        // page cache and the modified page writer writes them back in the background.
+        UnmapViewOfFile(pBuf);  // Only the current window stays mapped
+
+        ReleaseSemaphore(hSemWindowReady, 1, nullptr);  // Let the reader map this window
+        report.add(length);
+    }
+    if (aborted) {
+        CloseHandle(hSemWindowReady);
+        CloseHandle(hSemReaderDone);
+        CloseHandle(hAborted);
+        CloseHandle(hInfo);
+        CloseHandle(hMapFile);
+        CloseHandle(hFile);
+        return 1;
+    }
+    FlushFileBuffers(hFile);  // Wait once, for every window still being written back
+    auto end = std::chrono::high_resolution_clock::now();
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    std::cout << "Data written to " << (size >> 20) << " MB backing file.\n";
+    std::cout << "Time taken to write data: " << ms << " ms ("
+              << (ms ? (size >> 20) * 1000 / ms : 0) << " MB/s)\n";
+
+    // Wait for the reader to signal completion
+    std::cout << "Waiting for reader to finish...\n";
+    bool readerDone = waitUnlessAborted(hSemReaderDone, hAborted);  // Wait for reader to finish
+    if (readerDone)
+        std::cout << "Reader finished. Exiting writer program.\n";
+    else
+        std::cerr << "Reader aborted the transfer.\n";
+
+    // Cleanup
+    CloseHandle(hSemWindowReady);
+    CloseHandle(hSemReaderDone);
+    CloseHandle(hAborted);
+    CloseHandle(hInfo);
+    CloseHandle(hMapFile);
+    CloseHandle(hFile);
+
+    return readerDone ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    // writer.exe --file PATH --size BYTES [--window BYTES] streams through a file-backed window
+    if (argc > 1) {
+        WindowOptions options;
+        if (!parseWindowOptions(argc, argv, options, true) || options.size == 0) {
+            std::cerr << "Usage: writer.exe [--file PATH --size BYTES [--window BYTES]]\n";
+            return 1;
+        }
+        return writeFileBacked(options);
+    }
+
     // Create shared memory
     HANDLE hMapFile = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, DATA_SIZE, SHARED_MEMORY_NAME);
     if (!hMapFile) {